@@ -4,11 +4,18 @@
 #include <stdbool.h>
 #include <ctype.h>
 #include <stdlib.h>
+#include <pthread.h>
 
 #define XLEFT -86
 #define XRIGHT 86
 #define YBOTTOM -36
 #define YTOP 36
+#define NUM_THREADS 4
+#define AREA_PIECES 64
+#define AREA_MAXDEPTH 30
+#define AREA_MAXSPLITS 16000
+#define AREA_TOLERANCE 1e-6
+#define AREA_REPORTED 5
 
 /** The ASCII Graphing Calculator : Implemented in C */
 /** Author: Cooper Collier, June 2020                */
@@ -29,6 +36,12 @@ int x_pan;
 int y_pan;
 float scale;
 
+/** This variable controls whether the area under the curve is printed below the
+ * graph. The user toggles it with the 'a' command, and once it is on, the area is
+ * recomputed every time the graph is panned or zoomed. It is reset to false
+ * whenever the user generates a new graph.*/
+bool showArea;
+
 /** This is a binary tree of instructions, which stores the equation that will be
  * graphed. Each 'value' is an operation (*, + , -, etc) to perform on
  * the left and right branches--unless the node is a leaf node, in which case
@@ -300,11 +313,11 @@ struct instructionTree *parseMath(char equation[], int size, int loops) {
     return treePtr;
 }
 
-/** This function takes an operation and two floats, and applies the
+/** This function takes an operation and two doubles, and applies the
  * operation to them, returning the result. Some operations (like sin)
  * only need one operand, so in that case the other operand will enter
  * the function set to zero. */
-float doMath(char operation[], float x1, float x2) {
+double doMath(char operation[], double x1, double x2) {
     if (strcmp(operation, "+") == 0) {
         return x1 + x2;
     } else if (strcmp(operation, "-") == 0) {
@@ -362,7 +375,7 @@ float doMath(char operation[], float x1, float x2) {
 /** This function takes in a value for x, and mechanically runs it through
  * the instructionTree in a recursive fashion, calling doMath() each time.
  * Anytime "x" appears as a value in the tree, it is substituted with the current value of x. */
-float calculate(float x, struct instructionTree *treePtr) {
+double calculate(double x, struct instructionTree *treePtr) {
     struct instructionTree tree = *treePtr;
     if (tree.left == NULL && tree.right == NULL) {
         if (strcmp(tree.value, "x") == 0) {
@@ -379,6 +392,321 @@ float calculate(float x, struct instructionTree *treePtr) {
     }
 }
 
+/** This struct holds the running total for a numerical integral. 'area' and 'error'
+ * are the integral and its estimated error. 'skipped' is the total width of the
+ * intervals where the function was undefined (like ln x for x < 0), which are left
+ * out of the area. 'unconverged' is the error from the intervals that never reached
+ * the error tolerance (like tan x near pi/2), and 'failures' is how many of them there
+ * were. 'singularities' holds the x-values of the AREA_REPORTED worst ones, worst first,
+ * and 'worstErrors' holds their errors.*/
+struct areaResult {
+    double area;
+    double error;
+    double skipped;
+    double unconverged;
+    int failures;
+    double worstErrors[AREA_REPORTED];
+    double singularities[AREA_REPORTED];
+};
+
+/** This function records an unconverged interval at x with the given error. The
+ * failure is always counted, but x is only kept if it is one of the AREA_REPORTED
+ * worst so far. */
+void recordFailure(struct areaResult *result, double x, double error) {
+    int kept = result->failures < AREA_REPORTED ? result->failures : AREA_REPORTED;
+    result->failures++;
+    int i = kept;
+    if (i == AREA_REPORTED) {
+        if (error <= result->worstErrors[AREA_REPORTED - 1]) {
+            return;
+        }
+        i--;
+    }
+    for (; i > 0 && result->worstErrors[i - 1] < error; i--) {
+        result->worstErrors[i] = result->worstErrors[i - 1];
+        result->singularities[i] = result->singularities[i - 1];
+    }
+    result->worstErrors[i] = error;
+    result->singularities[i] = x;
+}
+
+/** This function applies the 15-point Gauss-Kronrod rule to the function on the
+ * interval [a, b]. The 7-point Gauss rule uses every other Kronrod node, so the
+ * difference between the two rules is a cheap estimate of the error. 'absArea' is
+ * the integral of |f|, which is used to set a relative error tolerance. This returns
+ * the number of nodes (out of 15) where the function is NaN, meaning it is undefined
+ * there. Those nodes count as zero, so 'area' and 'absArea' only cover the defined
+ * part, and 'error' is not usable. 'infinite' is set if the function is Inf at any
+ * node, meaning it blows up somewhere in the interval. */
+int gaussKronrod(double a, double b, struct instructionTree *treePtr,
+                 double *area, double *error, double *absArea, bool *infinite) {
+    static const double nodes[8] = {
+            0.991455371120812639206854697526329, 0.949107912342758524526189684047851,
+            0.864864423359769072789712788640926, 0.741531185599394439863864773280788,
+            0.586087235467691130294144845693013, 0.405845151377397166906606412076961,
+            0.207784955007898467600689403773245, 0.000000000000000000000000000000000};
+    static const double kronrodWeights[8] = {
+            0.022935322010529224963732008058970, 0.063092092629978553290700663189204,
+            0.104790010322250183839876322541518, 0.140653259715525918745189590510238,
+            0.169004726639267902826583426598550, 0.190350578064785409913256402421014,
+            0.204432940075298892414161999234649, 0.209482141084727828012999174891714};
+    static const double gaussWeights[4] = {
+            0.129484966168869693270611432679082, 0.279705391489276667901467771423780,
+            0.381830050505118944950369775488975, 0.417959183673469387755102040816327};
+    double center = (a + b) / 2;
+    double halfWidth = (b - a) / 2;
+    double kronrod = 0;
+    double gauss = 0;
+    double absolute = 0;
+    int undefined = 0;
+    *infinite = false;
+    for (int i = 0; i < 8; i++) {
+        double f1 = calculate(center - halfWidth * nodes[i], treePtr);
+        double f2 = 0;
+        if (i != 7) {
+            f2 = calculate(center + halfWidth * nodes[i], treePtr);
+        }
+        if (isnan(f1)) {
+            undefined++;
+            f1 = 0;
+        }
+        if (isnan(f2)) {
+            undefined++;
+            f2 = 0;
+        }
+        *infinite = *infinite || isinf(f1) || isinf(f2);
+        double f = f1 + f2;
+        kronrod += kronrodWeights[i] * f;
+        absolute += kronrodWeights[i] * (fabs(f1) + fabs(f2));
+        if (i % 2 == 1) {
+            gauss += gaussWeights[i / 2] * f;
+        }
+    }
+    if (!isfinite(absolute * halfWidth)) {
+        *infinite = true;
+    }
+    *area = kronrod * halfWidth;
+    *error = fabs((kronrod - gauss) * halfWidth);
+    *absArea = absolute * halfWidth;
+    return undefined;
+}
+
+/** This struct is one piece of the range that has been run through gaussKronrod.
+ * 'converged' is true if its error is small enough to use as-is. If the function
+ * is Inf at any node, 'area' is zero and 'error' is infinite, so these intervals are
+ * always the first ones to be split. If the function is undefined at some nodes, the
+ * interval touches the edge of an undefined region, and 'error' is the area of |f|
+ * over the defined nodes--so an edge where f is small is not worth splitting much.*/
+struct areaInterval {
+    double a;
+    double b;
+    double area;
+    double error;
+    int depth;
+    int undefined;
+    bool converged;
+};
+
+/** This function runs gaussKronrod on [a, b] and packs the result into an areaInterval. */
+struct areaInterval evaluateInterval(double a, double b, int depth, struct instructionTree *treePtr) {
+    struct areaInterval interval = {a, b, 0, 0, depth, 0, false};
+    double absArea;
+    bool infinite;
+    interval.undefined = gaussKronrod(a, b, treePtr, &interval.area, &interval.error, &absArea, &infinite);
+    if (infinite) {
+        interval.area = 0;
+        interval.error = HUGE_VAL;
+    } else if (interval.undefined > 0) {
+        interval.error = absArea;
+    } else {
+        interval.converged = interval.error <= AREA_TOLERANCE * fmax(absArea, b - a);
+    }
+    return interval;
+}
+
+/** This function adds a finished interval to 'result'. Intervals that are undefined at
+ * every node, or that still touch an undefined region after AREA_MAXDEPTH splits, are
+ * left out of the area. If the budget runs out before an edge of an undefined region
+ * is found, the defined nodes give the area and the undefined ones give the skipped
+ * width, and the error is added as usual--the function is not blowing up there, so
+ * this is not a failure. Intervals that never converged (like tan x near pi/2, or any
+ * other interval left over when the budget runs out) are added to 'unconverged'. */
+void finishInterval(struct areaInterval *interval, struct areaResult *result) {
+    if (interval->undefined == 15 || (interval->undefined > 0 && interval->depth >= AREA_MAXDEPTH)) {
+        result->skipped += interval->b - interval->a;
+        return;
+    }
+    result->area += interval->area;
+    if (interval->undefined > 0) {
+        result->skipped += (interval->b - interval->a) * interval->undefined / 15;
+        result->error += interval->error;
+        return;
+    }
+    result->error += interval->error;
+    if (!interval->converged) {
+        recordFailure(result, (interval->a + interval->b) / 2, interval->error);
+        result->unconverged += interval->error;
+    }
+}
+
+/** This function puts an interval onto 'heap', which is a binary max-heap ordered by
+ * error, so that heap[0] is always the interval with the biggest error. */
+void pushInterval(struct areaInterval heap[], int *heapSize, struct areaInterval interval) {
+    int i = (*heapSize)++;
+    while (i > 0 && heap[(i - 1) / 2].error < interval.error) {
+        heap[i] = heap[(i - 1) / 2];
+        i = (i - 1) / 2;
+    }
+    heap[i] = interval;
+}
+
+/** This function removes and returns the interval with the biggest error from 'heap'. */
+struct areaInterval popInterval(struct areaInterval heap[], int *heapSize) {
+    struct areaInterval worst = heap[0];
+    struct areaInterval last = heap[--(*heapSize)];
+    int i = 0;
+    while (2 * i + 1 < *heapSize) {
+        int child = 2 * i + 1;
+        if (child + 1 < *heapSize && heap[child + 1].error > heap[child].error) {
+            child++;
+        }
+        if (heap[child].error <= last.error) {
+            break;
+        }
+        heap[i] = heap[child];
+        i = child;
+    }
+    heap[i] = last;
+    return worst;
+}
+
+/** This function decides what happens to a freshly evaluated interval: it is either
+ * finished right away (converged, undefined everywhere, or split AREA_MAXDEPTH times),
+ * or it goes onto the heap to be split later. */
+void addInterval(struct areaInterval heap[], int *heapSize,
+                 struct areaInterval interval, struct areaResult *result) {
+    if (interval.converged || interval.undefined == 15 || interval.depth >= AREA_MAXDEPTH) {
+        finishInterval(&interval, result);
+    } else {
+        pushInterval(heap, heapSize, interval);
+    }
+}
+
+/** This struct is the argument to integrateSlice. Each thread gets one of these,
+ * and writes its share of the integral into 'result'.*/
+struct areaTask {
+    double left;
+    double right;
+    int thread;
+    struct instructionTree *treePtr;
+    struct areaResult result;
+};
+
+/** This function is run by each thread. The range is cut into AREA_PIECES equal
+ * pieces, and each thread takes every NUM_THREADS'th piece, so that a difficult
+ * region of the graph gets shared between the threads. Then the thread keeps splitting
+ * whichever of its intervals has the biggest error, until they have all converged or
+ * it has used up its share of AREA_MAXSPLITS. Whatever is left on the heap at that
+ * point is counted as unconverged, so the area is always printed in bounded time. */
+void *integrateSlice(void *arg) {
+    struct areaTask *task = arg;
+    int budget = AREA_MAXSPLITS / NUM_THREADS;
+    struct areaInterval *heap = malloc((AREA_PIECES / NUM_THREADS + 1 + budget) * sizeof(struct areaInterval));
+    int heapSize = 0;
+    double width = (task->right - task->left) / AREA_PIECES;
+    for (int i = task->thread; i < AREA_PIECES; i += NUM_THREADS) {
+        double a = task->left + i * width;
+        addInterval(heap, &heapSize, evaluateInterval(a, a + width, 0, task->treePtr), &task->result);
+    }
+    for (int splits = 0; heapSize > 0 && splits < budget; splits++) {
+        struct areaInterval worst = popInterval(heap, &heapSize);
+        double middle = (worst.a + worst.b) / 2;
+        addInterval(heap, &heapSize, evaluateInterval(worst.a, middle, worst.depth + 1, task->treePtr),
+                    &task->result);
+        addInterval(heap, &heapSize, evaluateInterval(middle, worst.b, worst.depth + 1, task->treePtr),
+                    &task->result);
+    }
+    while (heapSize > 0) {
+        struct areaInterval leftover = popInterval(heap, &heapSize);
+        finishInterval(&leftover, &task->result);
+    }
+    free(heap);
+    return NULL;
+}
+
+/** This function computes the integral of the instructionTree from left to right,
+ * spreading the work across NUM_THREADS threads. If a thread can't be started, its
+ * share of the work is done on this thread instead. The results are added up in
+ * thread order, so the same graph always gives the same answer. */
+struct areaResult integrate(double left, double right, struct instructionTree *treePtr) {
+    struct areaTask tasks[NUM_THREADS];
+    pthread_t threads[NUM_THREADS];
+    bool started[NUM_THREADS];
+    for (int i = 0; i < NUM_THREADS; i++) {
+        struct areaTask task = {left, right, i, treePtr, {0, 0, 0, 0, 0, {0}, {0}}};
+        tasks[i] = task;
+        started[i] = pthread_create(&threads[i], NULL, integrateSlice, &tasks[i]) == 0;
+        if (!started[i]) {
+            integrateSlice(&tasks[i]);
+        }
+    }
+    struct areaResult total = {0, 0, 0, 0, 0, {0}, {0}};
+    for (int i = 0; i < NUM_THREADS; i++) {
+        if (started[i]) {
+            pthread_join(threads[i], NULL);
+        }
+        total.area += tasks[i].result.area;
+        total.error += tasks[i].result.error;
+        total.skipped += tasks[i].result.skipped;
+        total.unconverged += tasks[i].result.unconverged;
+        int kept = tasks[i].result.failures < AREA_REPORTED ? tasks[i].result.failures : AREA_REPORTED;
+        for (int j = 0; j < kept; j++) {
+            recordFailure(&total, tasks[i].result.singularities[j], tasks[i].result.worstErrors[j]);
+        }
+        total.failures += tasks[i].result.failures - kept;
+    }
+    return total;
+}
+
+/** This function prints out the area under the curve between the left and right
+ * edges of the graph, along with the estimated error. It also tells the user if part
+ * of the graph was undefined. Some singularities (like ln x at 0) still have a finite
+ * area, so the area is only called undefined if the intervals that didn't converge
+ * make up a noticeable part of the answer. In that case, no number is printed, since
+ * it would be meaningless--instead we say how many intervals failed, and where the
+ * worst ones are. If every interval converged but the total overflowed, we say that
+ * the area is too large instead. */
+void printArea(int left, int right, struct instructionTree *treePtr) {
+    double from = (left * scale) + x_pan;
+    double to = (right * scale) + x_pan;
+    struct areaResult result = integrate(from, to, treePtr);
+    bool overflow = !isfinite(result.area);
+    bool divergent = result.failures > 0
+                     && (overflow || result.unconverged > 0.001 * fmax(fabs(result.area), 1));
+    if (divergent) {
+        printf("Area under the curve from X:%f to X:%f is undefined: the integral did not converge.\n",
+               from, to);
+        printf("The equation may blow up in this range (like tan x at pi/2), or change too "
+               "quickly to integrate.\n");
+        printf("It failed to converge on %d intervals. The worst are near", result.failures);
+        int kept = result.failures < AREA_REPORTED ? result.failures : AREA_REPORTED;
+        for (int i = 0; i < kept; i++) {
+            printf("%s X:%f", i == 0 ? "" : ",", result.singularities[i]);
+        }
+        printf(".\n");
+    } else if (overflow) {
+        printf("Area under the curve from X:%f to X:%f is too large to represent.\n", from, to);
+    } else {
+        printf("Area under the curve from X:%f to X:%f = %.10g (estimated error: %g)\n",
+               from, to, result.area, result.error);
+    }
+    if (result.skipped > 0) {
+        printf("Note: the equation is undefined over about %f units of this range, "
+               "so that part was left out of the area.\n", result.skipped);
+    }
+    printf("\n");
+}
+
 /** This function visualizes the graph by printing out every square. This function calls
  * the calculate function on x for every (x, y) pair, and only fills in a square if
  * calculate(x) == y. This functions also adds some asthetic borders and marks the coordinates of
@@ -404,10 +732,8 @@ void printGraph(int left, int right, int bottom, int top, struct instructionTree
     /** Part 3: Actually print out the contents of the graph.*/
     for (int y = top; y >= bottom; y--) {
         for (int x = left; x <= right; x++) {
-            int this_x = x;
-            this_x *= scale;
-            this_x -= x_pan;
-            float result1 = calculate(this_x, treePtr);
+            double this_x = (x * scale) + x_pan;
+            double result1 = calculate(this_x, treePtr);
             int result = round(result1);
             result -= y_pan;
             if (result == y) {
@@ -427,6 +753,10 @@ void printGraph(int left, int right, int bottom, int top, struct instructionTree
         printf("[]");
     }
     printf("\n\n");
+    /** Part 5: If the user has turned on the area display, print the area under the curve.*/
+    if (showArea) {
+        printArea(left, right, treePtr);
+    }
 }
 
 /** This function alters the 'scale' global variable and prints out
@@ -530,7 +860,10 @@ void printInstructions() {
            "clarify the order of operations for your equation. Once you have graphed an\n"
            "equation, you can pan n units in the x-direction by typing \"x n\", or pan\n"
            "n units in the y-direction by typing \"y n\", or zoom by a factor of n by \n"
-           "typing \"z n\". For zooming, if n is less than one then the graph will zoom in.\n\n"
+           "typing \"z n\". For zooming, if n is less than one then the graph will zoom in.\n"
+           "You can also type \"a\" to show the area under the curve (the integral) between\n"
+           "the left and right edges of the graph. It is updated every time you pan or\n"
+           "zoom, until you type \"a\" again to hide it.\n\n"
            "Here are some examples of correctly formatted equations:\n"
            "((sin x) * 3) ^ 1.5\n"
            "27 - ((x / -cosx) + (-2) * (log x))\n"
@@ -560,6 +893,7 @@ int main() {
         x_pan = 0;
         y_pan  = 0;
         scale = 1;
+        showArea = false;
         char equation[100];
         char cleanEquation[100];
         char input[100];
@@ -640,6 +974,7 @@ int main() {
                        " To pan the graph n units in the y direction, type \"y n\". \n");
                 printf("To zoom the graph by a factor of n, type \"z n\","
                        " where n is a decimal of you are zooming in. \n");
+                printf("To show or hide the area under the curve, type \"a\".\n");
                 printf("To draw a new graph, type anything else.\n");
                 scanf("%[^\n]%*c", input);
                 if (input[0] == 'x' && input[1] == ' ') {
@@ -648,6 +983,9 @@ int main() {
                     yPan(input, treePtr);
                 } else if (input[0] == 'z' && input[1] == ' ') {
                     zoom(input, treePtr);
+                } else if (strcmp(input, "a") == 0 || (strcmp(input, "A") == 0)) {
+                    showArea = !showArea;
+                    printGraph(XLEFT, XRIGHT, YBOTTOM, YTOP, treePtr);
                 } else if (strcmp(input, "i") == 0 || (strcmp(input, "I") == 0)) {
                     printInstructions();
                 } else if (strcmp(input, "q") == 0 || (strcmp(input, "Q") == 0)) {